@@ -8,16 +8,65 @@
 #include <PubSubClient.h>
 #include <ESP32Servo.h>
 #include <WiFiUdp.h>
-
+#include <ESPAsyncWebServer.h>
+#ifdef MQTT_TLS
+#include "TlsSessionClient.h"
+#endif
+
+#ifdef MQTT_TLS
+TlsSessionClient espClient;
+#else
 WiFiClient espClient;
+#endif
 PubSubClient client(espClient);
 
 // MQTT setup
 const char* ssid = "Wokwi-GUEST";
 const char* password = "";
 const char* mqttServer = "broker.emqx.io";  
+#ifdef MQTT_TLS
+const int mqttPort = 8883;
+// CA certificate that signed the broker certificate (replace with your own)
+const char* MQTT_CA_CERT = R"EOF(
+-----BEGIN CERTIFICATE-----
+-----END CERTIFICATE-----
+)EOF";
+#else
 const int mqttPort = 1883;
-
+#endif
+
+// MQTT reconnect parameters
+#define MQTT_RETRY_MIN 1000     // First retry delay (ms)
+#define MQTT_RETRY_MAX 30000    // Longest retry delay (ms)
+#define MQTT_CONNECT_TIMEOUT 3000  // TCP connect timeout per attempt (ms)
+#define MQTT_HANDSHAKE_TIMEOUT 5   // TLS handshake timeout per attempt (s)
+#define MQTT_SOCKET_TIMEOUT_S 5    // CONNACK and packet read timeout (s)
+#define MQTT_DNS_REFRESH 5         // Look the broker up again after this many failed attempts
+IPAddress mqttServerIP;                    // Cached broker address, so reconnects skip DNS
+bool mqttServerResolved = false;
+int mqttFailedAttempts = 0;                // Consecutive failed connection attempts
+unsigned long mqttDnsTime = 0;             // Duration of last DNS lookup (ms)
+unsigned long mqttTcpTime = 0;             // Duration of last TCP connect (ms)
+String mqttClientId;                       // Stable id so the broker keeps our session
+unsigned long lastMqttAttemptTime = 0;     // Last connection attempt time
+unsigned long mqttRetryDelay = 0;          // Current backoff delay
+unsigned long mqttHandshakeTime = 0;       // Duration of last TLS handshake (ms)
+unsigned long mqttConnectTime = 0;         // Duration of last full MQTT connect (ms)
+unsigned long mqttDisconnectedAt = 0;      // When the connection was lost
+int mqttReconnectCount = 0;                // Reconnects since boot
+
+// Local web server setup
+#define HTTP_PORT 80
+#define MAX_WS_CLIENTS 4  // Maximum concurrent WebSocket clients
+AsyncWebServer server(HTTP_PORT);
+AsyncWebSocket ws("/ws");
+unsigned long lastWsCleanupTime = 0; // Last WebSocket cleanup time
+
+// Web server callbacks run on the AsyncTCP task, so shared state is exchanged under this lock
+portMUX_TYPE webMux = portMUX_INITIALIZER_UNLOCKED;
+bool param_pending = false;   // A /set write is waiting for loop()
+char pending_topic[32];
+char pending_value[16];
 
 // OLED display parameters
 #define SCREEN_WIDTH 128
@@ -109,22 +158,45 @@ const char* topic_theta = "medibox/nodeRed/theta";
 const char* topic_y = "medibox/nodeRed/y";
 const char* topic_itemp = "medibox/nodeRed/itemp";
 
-int ts = 5; // Default sampling interval
-int tu = 120; // Default time constant
+int ts = 5; // Fastest sampling interval (s)
+int tu = 120; // Slowest sampling interval and heartbeat period (s)
 int theta_offset = 30; // Servo angle offset
 float control_factor = 0.75; // Control factor for LDR
 int Tmed = 30; // Default Tmed
 float y = 0.75; // Default gamma value
 
-int ldr_count = 0; // LDR count for averaging
-float total_intensity = 0; // Total intensity for averaging
-float average_intensity = 0; // Average intensity
+float average_intensity = 0; // Smoothed light intensity
 
 // Samples sending parameters
 unsigned long lastSampleTime = 0; // Last sample time
-unsigned long lastSentTime = 0; // Last sent time
 unsigned long lastServoTime = 0; // Last servo time
 
+// Adaptive sampling parameters
+#define CH_TEMP 0       // Temperature channel
+#define CH_HUM 1        // Humidity channel
+#define CH_LDR 2        // Light intensity channel
+const int NUM_CHANNELS = 3;
+const char* CHANNEL_TOPICS[NUM_CHANNELS] = {"medibox/temperature", "medibox/humidity", "medibox/ldr"};
+const float NOISE_BAND[NUM_CHANNELS] = {0.15, 0.5, 0.01};  // Change ignored as sensor noise
+const float RATE_LIMIT[NUM_CHANNELS] = {0.05, 0.25, 0.01}; // Rate of change (per minute) treated as activity
+const float STDDEV_LIMIT[NUM_CHANNELS] = {0.2, 1.0, 0.02}; // Spread between samples treated as activity
+const float SEND_DELTA[NUM_CHANNELS] = {0.5, 2.0, 0.05};   // Change since last report that forces a publish
+const float EWMA_ALPHA = 0.3;      // Smoothing factor for mean/variance tracking
+const float BACKOFF_FACTOR = 1.5;  // Interval growth per flat sample
+
+unsigned long sampleInterval = 5000; // Current sampling interval (ms), kept within [ts, tu]
+bool channel_valid[NUM_CHANNELS] = {false, false, false};
+float channel_value[NUM_CHANNELS] = {0, 0, 0};     // Latest reading
+float channel_mean[NUM_CHANNELS] = {0, 0, 0};      // EWMA of readings
+float channel_var[NUM_CHANNELS] = {0, 0, 0};       // EWMA of variance
+float channel_anchor[NUM_CHANNELS] = {0, 0, 0};    // Reading the rate of change is measured from
+unsigned long channel_anchor_time[NUM_CHANNELS] = {0, 0, 0};
+float last_sent_value[NUM_CHANNELS] = {0, 0, 0};   // Last published value
+unsigned long last_sent_time[NUM_CHANNELS] = {0, 0, 0};
+bool channel_sent[NUM_CHANNELS] = {false, false, false};
+bool channel_dirty[NUM_CHANNELS] = {false, false, false};  // Last publish failed, resend on reconnect
+#define WARNING_HEARTBEAT 10000  // Heartbeat while readings are out of range (ms)
+
 // Function prototypes
 void printLine(String text, String clearDisplay = "n", int textSize = 1, int column = 0, int row = 0);
 void updateTime();
@@ -144,6 +216,20 @@ void executeMode(int mode);
 void enterMenu();
 void callback(char* topic, byte* payload, unsigned int length);
 float getLDR();
+bool connectMQTT();
+bool checkParameter(const char* topic, String value);
+bool applyParameter(const char* topic, String value);
+void applyPendingParameter();
+void setupWebServer();
+void onWsEvent(AsyncWebSocket* socket, AsyncWebSocketClient* wsClient, AwsEventType type, void* arg, uint8_t* data, size_t len);
+void streamChannel(int channel, const char* value, AsyncWebSocketClient* wsClient = nullptr);
+bool updateChannel(int channel, float value);
+void sampleSensors();
+void publishChannel(int channel, float value, unsigned long sentAt);
+void publishIfChanged(int channel, unsigned long now, unsigned long heartbeatMs);
+void publishTelemetry();
+void flushPendingChannels();
+unsigned long nextSampleDelay();
 int calculateServoAngle(float I, float ts, float tu, float T, float theta_offset, float gamma, float Tmed);
 
 void setup() {
@@ -186,6 +272,12 @@ void setup() {
   }
 
   printLine("Connected to WiFi", "n", 1, 0, 5);
+  printLine(WiFi.localIP().toString(), "n", 1, 0, 20);
+  Serial.print("Local dashboard: http://");
+  Serial.println(WiFi.localIP());
+
+  // Start the local page before NTP so it is reachable even without an uplink
+  setupWebServer();
   delay(2000);
   display.clearDisplay();
 
@@ -209,59 +301,56 @@ void setup() {
   printLine("Welcome to Medibox!", "y", 1, 10, 30);
   delay(2000);
 
+#ifdef MQTT_TLS
+  espClient.setCACert(MQTT_CA_CERT);
+  espClient.setHandshakeTimeout(MQTT_HANDSHAKE_TIMEOUT);
+#endif
+  mqttClientId = "medibox-" + WiFi.macAddress();
   client.setServer(mqttServer, mqttPort);   //MQTT broker's address (server) and port number
+  client.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);   //bound how long a connect attempt waits for CONNACK
   
   client.setCallback(callback);   //automatically called whenever a message is received on a subscribed topic
-
-  client.subscribe(topic_ts);
-  client.subscribe(topic_tu);
-  client.subscribe(topic_theta);
-  client.subscribe(topic_y);
-  client.subscribe(topic_itemp);
 }
 
 
 void loop(){
-  client.loop();
+  // Reconnect with backoff; each attempt is bounded by the connect, handshake and socket timeouts
   if (!client.connected()) {
-    while (!client.connect("WokwiClient")) {
-      delay(500);
+    if (mqttDisconnectedAt == 0 && mqttConnectTime != 0) {
+      mqttDisconnectedAt = millis();  // Connection was lost after a successful connect
+    }
+    if (millis() - lastMqttAttemptTime >= mqttRetryDelay) {
+      lastMqttAttemptTime = millis();
+      if (connectMQTT()) {
+        mqttRetryDelay = 0;
+        mqttFailedAttempts = 0;
+      } else {
+        mqttFailedAttempts++;
+        mqttRetryDelay = constrain(mqttRetryDelay * 2, MQTT_RETRY_MIN, MQTT_RETRY_MAX);
+      }
     }
-    Serial.println("Connected to MQTT broker");
   }
-  client.subscribe(topic_ts);
-  client.subscribe(topic_tu);
-  client.subscribe(topic_theta);
-  client.subscribe(topic_y);
-  client.subscribe(topic_itemp);
   client.loop();
 
 
-  // Control servo motor based on LDR intensity
-  if (millis() - lastSampleTime >= ts * 1000) {
+  // Sample sensors on the adaptive interval and publish changed values
+  if (millis() - lastSampleTime >= nextSampleDelay()) {
     lastSampleTime = millis();
-    float intensity = 1 - getLDR();
-    total_intensity = intensity + total_intensity;
-    ldr_count++;
-  }
-
-  if (millis() - lastSentTime >= 1000 * tu) {
-      lastSentTime = millis();
-      if (ldr_count > 0) {
-          average_intensity = total_intensity / ldr_count;
-          sprintf(ldrArr, "%.2f", average_intensity);
-          client.publish("medibox/ldr", ldrArr);
-          Serial.print("Average LDR Intensity: ");
-          Serial.println(ldrArr);
-          total_intensity = 0;
-          ldr_count = 0;
-      } else {
-          Serial.println("Warning: ldr_count is 0");
-      }
+    sampleSensors();
+    publishTelemetry();
   }
 
+  applyPendingParameter();
+
+  // Drop WebSocket clients that disconnected or exceed the limit
+  if (millis() - lastWsCleanupTime >= 1000) {
+    lastWsCleanupTime = millis();
+    ws.cleanupClients(MAX_WS_CLIENTS);
+  }
+
+  // Control servo motor based on LDR intensity
   if(millis() - lastServoTime >= 500) {
-    float T = dhtSensor.getTemperature();
+    float T = channel_value[CH_TEMP];
     float I = average_intensity;
     int servoAngle = calculateServoAngle(I, ts, tu, T, theta_offset, y, Tmed);
     servo.write(servoAngle);
@@ -279,6 +368,88 @@ void loop(){
   }
 } 
 
+// Connect to the broker with a persistent session and record timing
+bool connectMQTT() {
+  unsigned long start = millis();
+
+  // Resolve the broker once; look it up again only after repeated failures in case it moved
+  mqttDnsTime = 0;
+  if (!mqttServerResolved || mqttFailedAttempts >= MQTT_DNS_REFRESH) {
+    IPAddress ip;
+    if (WiFi.hostByName(mqttServer, ip)) {
+      mqttServerIP = ip;
+      mqttServerResolved = true;
+      client.setServer(mqttServerIP, mqttPort);
+    } else if (!mqttServerResolved) {
+      Serial.println("MQTT DNS lookup failed");
+      return false;
+    }
+    mqttFailedAttempts = 0;
+    mqttDnsTime = millis() - start;
+  }
+
+  // Open the TCP/TLS connection first so its phases can be timed on their own
+  unsigned long transportStart = millis();
+  if (!espClient.connected()) {
+#ifdef MQTT_TLS
+    bool opened = espClient.connect(mqttServerIP, mqttPort, MQTT_CONNECT_TIMEOUT, mqttServer);
+#else
+    bool opened = espClient.connect(mqttServerIP, mqttPort, MQTT_CONNECT_TIMEOUT);
+#endif
+    if (!opened) {
+      Serial.println("MQTT transport connect failed");
+      return false;
+    }
+#ifdef MQTT_TLS
+    mqttHandshakeTime = espClient.handshakeTime();
+#else
+    mqttHandshakeTime = 0;
+#endif
+    mqttTcpTime = millis() - transportStart - mqttHandshakeTime;
+  }
+
+  // cleanSession=false keeps subscriptions and queued QoS 1 messages across reconnects
+  if (!client.connect(mqttClientId.c_str(), nullptr, nullptr, nullptr, 0, false, nullptr, false)) {
+    Serial.print("MQTT connect failed, state ");
+    Serial.println(client.state());
+    espClient.stop();
+    return false;
+  }
+  mqttConnectTime = millis() - start;
+
+  client.subscribe(topic_ts, 1);
+  client.subscribe(topic_tu, 1);
+  client.subscribe(topic_theta, 1);
+  client.subscribe(topic_y, 1);
+  client.subscribe(topic_itemp, 1);
+  flushPendingChannels();
+
+  Serial.print("Connected to MQTT broker (dns ");
+  Serial.print(mqttDnsTime);
+  Serial.print(" ms, tcp ");
+  Serial.print(mqttTcpTime);
+#ifdef MQTT_TLS
+  Serial.print(" ms, tls ");
+  Serial.print(mqttHandshakeTime);
+  Serial.print(espClient.sessionResumed() ? " ms resumed" : " ms full");
+#else
+  Serial.print(" ms");
+#endif
+  Serial.print(", total ");
+  Serial.print(mqttConnectTime);
+  Serial.print(" ms");
+  if (mqttDisconnectedAt != 0) {
+    mqttReconnectCount++;
+    Serial.print(", offline ");
+    Serial.print(millis() - mqttDisconnectedAt);
+    Serial.print(" ms, reconnect #");
+    Serial.print(mqttReconnectCount);
+  }
+  Serial.println(")");
+  mqttDisconnectedAt = 0;
+  return true;
+}
+
 // Display text on OLED screen
 void printLine(String text, String clearDisplay, int textSize, int column, int row) {
   if (clearDisplay == "y") {
@@ -383,15 +554,15 @@ void showWarning(float value, float thresholdLow, float thresholdHigh,
 
 // Check temperature and humidity conditions
 void checkEnvironmentalConditions() {
-  TempAndHumidity data = dhtSensor.getTempAndHumidity();
+  // Use the latest adaptive sample instead of polling the sensor every loop
+  if (!channel_valid[CH_TEMP] || !channel_valid[CH_HUM]) {
+    return;
+  }
+  TempAndHumidity data;
+  data.temperature = channel_value[CH_TEMP];
+  data.humidity = channel_value[CH_HUM];
   int counter = 0;
 
-  // Send values to Node-Red dashboard
-  String(data.temperature, 1).toCharArray(tempArr, 6);
-  String(data.humidity, 1).toCharArray(humArr, 6);
-  // mqttClient.publish("medibox/temperature", tempArr);
-  // mqttClient.publish("medibox/humidity", humArr);
-
   // Continue checking while conditions are outside safe ranges
   while(data.temperature < TEMP_LOW || data.temperature > TEMP_HIGH || 
         data.humidity < HUMIDITY_LOW || data.humidity > HUMIDITY_HIGH) {
@@ -414,14 +585,27 @@ void checkEnvironmentalConditions() {
 
     // Get updated readings
     data = dhtSensor.getTempAndHumidity();
-    String(data.temperature, 1).toCharArray(tempArr, 6);
-    String(data.humidity, 1).toCharArray(humArr, 6);
     if (!client.connected()) {
       Serial.println("Reconnecting to MQTT...");
     }
     client.loop();
-    client.publish("medibox/temperature", tempArr);
-    client.publish("medibox/humidity", humArr);
+    if (!isnan(data.temperature)) {
+      updateChannel(CH_TEMP, data.temperature);
+      publishIfChanged(CH_TEMP, millis(), WARNING_HEARTBEAT);
+    }
+    if (!isnan(data.humidity)) {
+      updateChannel(CH_HUM, data.humidity);
+      publishIfChanged(CH_HUM, millis(), WARNING_HEARTBEAT);
+    }
+
+    // Keep checking the last good readings if the sensor read failed
+    data.temperature = channel_value[CH_TEMP];
+    data.humidity = channel_value[CH_HUM];
+  }
+
+  // Readings were changing while out of range, so resume fast sampling
+  if (counter > 0) {
+    sampleInterval = ts * 1000UL;
   }
 
   // Turn off warning indicators when conditions return to normal
@@ -656,29 +840,66 @@ void callback(char* topic, byte* payload, unsigned int length) {
   }
   Serial.println(messageTemp);
 
+  applyParameter(topic, messageTemp);
+}
+
+// Apply a control parameter received from Node-RED or the local web server
+bool applyParameter(const char* topic, String value) {
+  if (!checkParameter(topic, value)) {
+    return false;
+  }
+
   if (strcmp(topic, topic_ts) == 0) {
-    if(messageTemp.toInt() > 0) {
-      ts = messageTemp.toInt();
+      ts = value.toInt();
       Serial.print("Updated ts: ");
       Serial.println(ts);
-    }
+      sampleInterval = ts * 1000UL;  // Re-enter fast sampling with the new floor
   } else if (strcmp(topic, topic_tu) == 0) {
-      tu = messageTemp.toInt();
+      tu = value.toInt();
       Serial.print("Updated tu: ");
       Serial.println(tu);
   } else if (strcmp(topic, topic_theta) == 0) {
-      theta_offset = messageTemp.toInt();
+      theta_offset = value.toInt();
       Serial.print("Updated theta: ");
       Serial.println(theta_offset);
   } else if (strcmp(topic, topic_y) == 0) {
-      y = messageTemp.toFloat();
+      y = value.toFloat();
       Serial.print("Updated y: ");
       Serial.println(y);
   } else if (strcmp(topic, topic_itemp) == 0) {
-      Tmed = messageTemp.toInt();
+      Tmed = value.toInt();
       Serial.print("Updated itemp: ");
       Serial.println(Tmed);
   }
+  return true;
+}
+
+// Check whether a parameter write names a known topic with an acceptable value
+bool checkParameter(const char* topic, String value) {
+  if (strcmp(topic, topic_ts) == 0 || strcmp(topic, topic_tu) == 0) {
+    return value.toInt() > 0;
+  }
+  return strcmp(topic, topic_theta) == 0 || strcmp(topic, topic_y) == 0 ||
+         strcmp(topic, topic_itemp) == 0;
+}
+
+// Apply a parameter write queued by the web server on the loop() task
+void applyPendingParameter() {
+  char topic[sizeof(pending_topic)];
+  char value[sizeof(pending_value)];
+
+  portENTER_CRITICAL(&webMux);
+  bool pending = param_pending;
+  if (pending) {
+    memcpy(topic, pending_topic, sizeof(topic));
+    memcpy(value, pending_value, sizeof(value));
+    param_pending = false;
+  }
+  portEXIT_CRITICAL(&webMux);
+
+  if (pending) {
+    applyParameter(topic, String(value));
+  }
 }
 
 float getLDR() {
@@ -687,6 +908,138 @@ float getLDR() {
   return LDRvalue / 4095.0;
 }
 
+// Track a new reading for a channel and report whether it is changing
+bool updateChannel(int channel, float value) {
+  if (isnan(value)) {
+    return false;  // Ignore failed sensor reads
+  }
+  unsigned long now = millis();
+  if (!channel_valid[channel]) {
+    channel_valid[channel] = true;
+    channel_value[channel] = value;
+    channel_mean[channel] = value;
+    channel_var[channel] = 0;
+    channel_anchor[channel] = value;
+    channel_anchor_time[channel] = now;
+    return true;
+  }
+
+  float diff = value - channel_mean[channel];
+  channel_mean[channel] += EWMA_ALPHA * diff;
+  channel_var[channel] = (1 - EWMA_ALPHA) * (channel_var[channel] + EWMA_ALPHA * diff * diff);
+  channel_value[channel] = value;
+  bool active = sqrt(channel_var[channel]) > STDDEV_LIMIT[channel];
+
+  // Measure the rate of change over the time since the reading last left the noise band,
+  // so slow drifts are caught regardless of the current sampling interval
+  float change = fabs(value - channel_anchor[channel]);
+  if (change > NOISE_BAND[channel]) {
+    float elapsedMin = (now - channel_anchor_time[channel]) / 60000.0;
+    active |= elapsedMin <= 0 || change / elapsedMin > RATE_LIMIT[channel];
+    channel_anchor[channel] = value;
+    channel_anchor_time[channel] = now;
+  }
+  return active;
+}
+
+// Read all sensors and adapt the sampling interval between ts and tu
+void sampleSensors() {
+  TempAndHumidity data = dhtSensor.getTempAndHumidity();
+  float intensity = 1 - getLDR();
+
+  bool active = false;
+  active |= updateChannel(CH_TEMP, data.temperature);
+  active |= updateChannel(CH_HUM, data.humidity);
+  active |= updateChannel(CH_LDR, intensity);
+
+  unsigned long minInterval = ts * 1000UL;
+  unsigned long maxInterval = max(tu, ts) * 1000UL;
+  if (active) {
+    sampleInterval = minInterval;  // Jump straight to the fastest rate on any event
+  } else {
+    sampleInterval = sampleInterval * BACKOFF_FACTOR;
+  }
+  sampleInterval = constrain(sampleInterval, minInterval, maxInterval);
+}
+
+// Publish a single channel value and remember it for send-on-delta
+void publishChannel(int channel, float value, unsigned long sentAt) {
+  if (isnan(value)) {
+    return;
+  }
+  char* buffer = channel == CH_TEMP ? tempArr : channel == CH_HUM ? humArr : ldrArr;
+  char text[sizeof(tempArr)];
+  if (channel == CH_LDR) {
+    snprintf(text, sizeof(text), "%.2f", value);
+  } else {
+    snprintf(text, sizeof(text), "%.1f", value);
+  }
+
+  // The web server snapshots these buffers from another task
+  portENTER_CRITICAL(&webMux);
+  memcpy(buffer, text, sizeof(text));
+  channel_sent[channel] = true;
+  portEXIT_CRITICAL(&webMux);
+
+  streamChannel(channel, buffer);
+
+  // Only a delivered value counts for send-on-delta; otherwise resend once the broker is back
+  if (client.publish(CHANNEL_TOPICS[channel], buffer)) {
+    last_sent_value[channel] = value;
+    last_sent_time[channel] = sentAt;
+    channel_dirty[channel] = false;
+  } else {
+    channel_dirty[channel] = true;
+  }
+}
+
+// Publish a channel that moved past its deadband, missed its heartbeat or failed to send
+void publishIfChanged(int channel, unsigned long now, unsigned long heartbeatMs) {
+  float value = channel == CH_LDR ? average_intensity : channel_value[channel];
+  bool heartbeat = (long)(now - last_sent_time[channel]) >= (long)heartbeatMs;
+  if (!channel_sent[channel] || channel_dirty[channel] || heartbeat ||
+      fabs(value - last_sent_value[channel]) >= SEND_DELTA[channel]) {
+    publishChannel(channel, value, now);
+    if (channel == CH_LDR) {
+      Serial.print("Average LDR Intensity: ");
+      Serial.println(ldrArr);
+    }
+  }
+}
+
+// Publish channels that moved past their deadband or whose heartbeat expired
+void publishTelemetry() {
+  average_intensity = channel_mean[CH_LDR];
+
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    if (channel_valid[i]) {
+      publishIfChanged(i, lastSampleTime, tu * 1000UL);
+    }
+  }
+}
+
+// Send the latest value of channels whose publish failed while the broker was down
+void flushPendingChannels() {
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    if (channel_valid[i] && channel_dirty[i]) {
+      publishIfChanged(i, millis(), tu * 1000UL);
+    }
+  }
+}
+
+// Time from the last sample until the next one: the adaptive interval or the earliest heartbeat
+unsigned long nextSampleDelay() {
+  unsigned long delayMs = sampleInterval;
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    if (!channel_sent[i] || channel_dirty[i]) {
+      continue;  // Dirty channels are resent on reconnect, not by polling
+    }
+    long remaining = (long)(last_sent_time[i] + tu * 1000UL - lastSampleTime);
+    delayMs = min(delayMs, (unsigned long)max(remaining, 0L));
+  }
+  return delayMs;
+}
+
 int calculateServoAngle(float I, float ts, float tu, float T, float theta_offset, float gamma, float Tmed) {
   if (ts <= 0 || tu <= 0 || Tmed == 0) {
     return theta_offset;  // fallback to safe value
@@ -698,4 +1051,126 @@ int calculateServoAngle(float I, float ts, float tu, float T, float theta_offset
   theta = constrain(theta, 0, 180);
 
   return (int)theta;
+}
+
+// Lightweight status page served from flash
+const char STATUS_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html>
+<html><head><meta name="viewport" content="width=device-width,initial-scale=1"><title>Medibox</title></head>
+<body style="font-family:sans-serif">
+<h2>Smart Medibox</h2>
+<p>Temperature: <b id="temperature">-</b> &deg;C</p>
+<p>Humidity: <b id="humidity">-</b> %</p>
+<p>Light Intensity: <b id="ldr">-</b></p>
+<p id="state">Connecting...</p>
+<form onsubmit="setParam(this);return false">
+<select name="name"><option>ts</option><option>tu</option><option>theta</option><option>y</option><option>itemp</option></select>
+<input name="value" size="6"> <button>Set</button>
+</form>
+<p id="result"></p>
+<script>
+function setParam(form){
+  var result=document.getElementById('result');
+  fetch('/set',{method:'POST',body:new URLSearchParams(new FormData(form))}).then(function(r){
+    return r.text().then(function(t){result.textContent=r.ok?'Saved':'Rejected ('+r.status+'): '+t;});
+  }).catch(function(){result.textContent='Request failed';});
+}
+function connect(){
+  var ws=new WebSocket('ws://'+location.host+'/ws');
+  ws.onopen=function(){document.getElementById('state').textContent='Live';};
+  ws.onclose=function(){document.getElementById('state').textContent='Disconnected';setTimeout(connect,2000);};
+  ws.onmessage=function(e){var m=JSON.parse(e.data);document.getElementById(m.topic.split('/')[1]).textContent=m.value;};
+}
+connect();
+</script>
+</body></html>)rawliteral";
+
+// Start the local HTTP/WebSocket server for broker-less monitoring
+void setupWebServer() {
+  ws.onEvent(onWsEvent);
+  server.addHandler(&ws);
+
+  server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "text/html", STATUS_PAGE);
+  });
+
+  // Accept the same parameter writes as the MQTT callback, e.g. name=ts&value=10
+  server.on("/set", HTTP_POST, [](AsyncWebServerRequest* request) {
+    if (!request->hasParam("name", true) || !request->hasParam("value", true)) {
+      request->send(400, "text/plain", "Missing name or value");
+      return;
+    }
+    String topic = "medibox/nodeRed/" + request->getParam("name", true)->value();
+    String value = request->getParam("value", true)->value();
+    if (!checkParameter(topic.c_str(), value) || value.length() >= sizeof(pending_value)) {
+      request->send(400, "text/plain", "Unknown parameter or invalid value");
+      return;
+    }
+
+    // Hand the write to loop() so sampling state is only changed on that task
+    bool queued = false;
+    portENTER_CRITICAL(&webMux);
+    if (!param_pending) {
+      strncpy(pending_topic, topic.c_str(), sizeof(pending_topic) - 1);
+      pending_topic[sizeof(pending_topic) - 1] = '\0';
+      strncpy(pending_value, value.c_str(), sizeof(pending_value) - 1);
+      pending_value[sizeof(pending_value) - 1] = '\0';
+      param_pending = true;
+      queued = true;
+    }
+    portEXIT_CRITICAL(&webMux);
+
+    if (queued) {
+      request->send(204);
+    } else {
+      request->send(503, "text/plain", "Previous write still pending");
+    }
+  });
+
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    request->send(404, "text/plain", "Not found");
+  });
+
+  server.begin();
+}
+
+// Handle WebSocket connections, enforcing the client limit
+void onWsEvent(AsyncWebSocket* socket, AsyncWebSocketClient* wsClient, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+  if (type == WS_EVT_CONNECT) {
+    if (socket->count() > MAX_WS_CLIENTS) {
+      wsClient->close(1013, "Too many clients");
+      return;
+    }
+    // Send the latest readings so the page is populated immediately
+    char values[NUM_CHANNELS][sizeof(tempArr)];
+    bool sent[NUM_CHANNELS];
+    portENTER_CRITICAL(&webMux);
+    memcpy(values[CH_TEMP], tempArr, sizeof(tempArr));
+    memcpy(values[CH_HUM], humArr, sizeof(humArr));
+    memcpy(values[CH_LDR], ldrArr, sizeof(ldrArr));
+    memcpy(sent, channel_sent, sizeof(sent));
+    portEXIT_CRITICAL(&webMux);
+
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+      if (sent[i]) {
+        streamChannel(i, values[i], wsClient);
+      }
+    }
+  }
+}
+
+// Stream a channel value formatted for MQTT to WebSocket clients
+void streamChannel(int channel, const char* value, AsyncWebSocketClient* wsClient) {
+  if (ws.count() == 0) {
+    return;
+  }
+  char frame[64];
+  int len = snprintf(frame, sizeof(frame), "{\"topic\":\"%s\",\"value\":%s}", CHANNEL_TOPICS[channel], value);
+
+  // One shared buffer is referenced by every client queue instead of copied per client
+  AsyncWebSocketMessageBuffer* message = ws.makeBuffer((uint8_t*)frame, len);
+  if (wsClient != nullptr) {
+    wsClient->text(message);
+  } else {
+    ws.textAll(message);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "TlsSessionClient.h"
+#include <mbedtls/version.h>
+#include <lwip/sockets.h>
+
+#define TLS_WRITE_TIMEOUT 5000  // Give up on a stalled write after this long (ms)
+#define TLS_CONNECT_TIMEOUT 3000  // Default TCP connect timeout (ms)
+
+// Handshake state is a private field from mbedTLS 3 onwards
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define SSL_STATE(ssl) ((ssl).MBEDTLS_PRIVATE(state))
+#else
+#define SSL_STATE(ssl) ((ssl).state)
+#endif
+
+TlsSessionClient::TlsSessionClient() {
+  _net.fd = -1;
+  mbedtls_ssl_init(&_ssl);
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_x509_crt_init(&_ca);
+  mbedtls_entropy_init(&_entropy);
+  mbedtls_ctr_drbg_init(&_drbg);
+  mbedtls_ssl_session_init(&_session);
+}
+
+TlsSessionClient::~TlsSessionClient() {
+  stop();
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ctr_drbg_free(&_drbg);
+  mbedtls_entropy_free(&_entropy);
+  mbedtls_x509_crt_free(&_ca);
+  mbedtls_ssl_config_free(&_conf);
+}
+
+void TlsSessionClient::setCACert(const char* caCert) {
+  _caCert = caCert;
+}
+
+void TlsSessionClient::setHandshakeTimeout(unsigned long seconds) {
+  _handshakeTimeout = seconds * 1000UL;
+}
+
+// Build the TLS configuration once and reuse it for every connection
+bool TlsSessionClient::setupConfig() {
+  if (_configured) {
+    return true;
+  }
+
+  // The RNG is seeded once even if a later step fails and is retried
+  if (!_seeded) {
+    const char* pers = "medibox";
+    if (mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                              (const unsigned char*)pers, strlen(pers)) != 0) {
+      Serial.println("TLS: RNG seed failed");
+      return false;
+    }
+    _seeded = true;
+  }
+
+  // Start from clean contexts so a failed attempt can be retried
+  mbedtls_x509_crt_free(&_ca);
+  mbedtls_x509_crt_init(&_ca);
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_ssl_config_init(&_conf);
+
+  if (_caCert == nullptr ||
+      mbedtls_x509_crt_parse(&_ca, (const unsigned char*)_caCert, strlen(_caCert) + 1) != 0) {
+    Serial.println("TLS: invalid CA certificate");
+    return false;
+  }
+  if (mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+    Serial.println("TLS: config failed");
+    return false;
+  }
+
+  // Resumption is detected from the TLS 1.2 handshake flow
+#if MBEDTLS_VERSION_MAJOR >= 3
+  mbedtls_ssl_conf_max_tls_version(&_conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#else
+  mbedtls_ssl_conf_max_version(&_conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+#endif
+  mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  mbedtls_ssl_conf_ca_chain(&_conf, &_ca, nullptr);
+  mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+  _configured = true;
+  return true;
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip, port, TLS_CONNECT_TIMEOUT);
+}
+
+int TlsSessionClient::connect(const char* host, uint16_t port) {
+  return connect(host, port, TLS_CONNECT_TIMEOUT);
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+  return connect(ip, port, timeout, nullptr);
+}
+
+// Connect to an already resolved address while keeping SNI and certificate name checks
+int TlsSessionClient::connect(IPAddress ip, uint16_t port, int32_t timeout, const char* hostname) {
+  stop();
+  if (!setupConfig() || !_tcp.connect(ip, port, timeout)) {
+    return 0;
+  }
+  return startTls(hostname);
+}
+
+int TlsSessionClient::connect(const char* host, uint16_t port, int32_t timeout) {
+  stop();
+  if (!setupConfig() || !_tcp.connect(host, port, timeout)) {
+    return 0;
+  }
+  return startTls(host);
+}
+
+// Run the handshake, offering the saved session so the server can skip the full exchange
+int TlsSessionClient::startTls(const char* host) {
+  unsigned long start = millis();
+  _net.fd = _tcp.fd();
+
+  // Non-blocking socket so the handshake deadline below is honoured and reads never stall loop()
+  mbedtls_net_set_nonblock(&_net);
+
+  if (mbedtls_ssl_setup(&_ssl, &_conf) != 0 ||
+      (host != nullptr && mbedtls_ssl_set_hostname(&_ssl, host) != 0)) {
+    stop();
+    return 0;
+  }
+  if (_haveSession && mbedtls_ssl_set_session(&_ssl, &_session) != 0) {
+    _haveSession = false;
+  }
+  mbedtls_ssl_set_bio(&_ssl, &_net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+  // A resumed TLS 1.2 handshake goes from ServerHello straight to ChangeCipherSpec
+  bool fullHandshake = false;
+  while (SSL_STATE(_ssl) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    if (SSL_STATE(_ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+      fullHandshake = true;
+    }
+    int ret = mbedtls_ssl_handshake_step(&_ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (millis() - start >= _handshakeTimeout) {
+        Serial.println("TLS: handshake timed out");
+        stop();
+        return 0;
+      }
+      delay(1);
+    } else if (ret != 0) {
+      Serial.print("TLS: handshake failed, error -0x");
+      Serial.println(-ret, HEX);
+      _haveSession = false;  // Do not offer a session the server may have rejected
+      stop();
+      return 0;
+    }
+  }
+
+  _resumed = _haveSession && !fullHandshake;
+  _handshakeTime = millis() - start;
+  _connected = true;
+
+  // Keep the newest session (and ticket) for the next reconnect
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  _haveSession = mbedtls_ssl_get_session(&_ssl, &_session) == 0;
+  return 1;
+}
+
+size_t TlsSessionClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t TlsSessionClient::write(const uint8_t* buf, size_t size) {
+  if (!_connected) {
+    return 0;
+  }
+  unsigned long start = millis();
+  size_t written = 0;
+  while (written < size) {
+    int ret = mbedtls_ssl_write(&_ssl, buf + written, size - written);
+    if (ret > 0) {
+      written += ret;
+    } else if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+               millis() - start >= TLS_WRITE_TIMEOUT) {
+      stop();
+      break;
+    } else {
+      delay(1);
+    }
+  }
+  return written;
+}
+
+int TlsSessionClient::available() {
+  if (!_connected) {
+    return 0;
+  }
+  int buffered = mbedtls_ssl_get_bytes_avail(&_ssl) + (_peeked >= 0 ? 1 : 0);
+  if (buffered > 0) {
+    return buffered;
+  }
+
+  // Only decrypt when the socket has data, so polling never blocks
+  int pending = 0;
+  if (lwip_ioctl(_net.fd, FIONREAD, &pending) < 0 || pending <= 0) {
+    return 0;
+  }
+  int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+  if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    stop();
+    return 0;
+  }
+  return mbedtls_ssl_get_bytes_avail(&_ssl);
+}
+
+int TlsSessionClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsSessionClient::read(uint8_t* buf, size_t size) {
+  if (size == 0 || available() == 0) {
+    return -1;
+  }
+  int count = 0;
+  if (_peeked >= 0) {
+    buf[count++] = (uint8_t)_peeked;
+    _peeked = -1;
+    if (count == (int)size || mbedtls_ssl_get_bytes_avail(&_ssl) == 0) {
+      return count;
+    }
+  }
+  int ret = mbedtls_ssl_read(&_ssl, buf + count, size - count);
+  if (ret > 0) {
+    return count + ret;
+  }
+  if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    stop();
+  }
+  return count > 0 ? count : -1;
+}
+
+int TlsSessionClient::peek() {
+  if (_peeked < 0) {
+    _peeked = read();
+  }
+  return _peeked;
+}
+
+void TlsSessionClient::flush() {
+}
+
+void TlsSessionClient::stop() {
+  if (_connected) {
+    mbedtls_ssl_close_notify(&_ssl);
+  }
+  mbedtls_ssl_free(&_ssl);
+  mbedtls_ssl_init(&_ssl);
+  _tcp.stop();  // Closes the socket shared with _net
+  _net.fd = -1;
+  _connected = false;
+  _peeked = -1;
+}
+
+uint8_t TlsSessionClient::connected() {
+  if (_connected && !_tcp.connected() && available() == 0) {
+    stop();
+  }
+  return _connected;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+// TLS client for PubSubClient that resumes the previous session on reconnect
+#ifndef TLS_SESSION_CLIENT_H
+#define TLS_SESSION_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+class TlsSessionClient : public Client {
+public:
+  TlsSessionClient();
+  ~TlsSessionClient();
+
+  void setCACert(const char* caCert);
+  void setHandshakeTimeout(unsigned long seconds);
+
+  int connect(IPAddress ip, uint16_t port);
+  int connect(const char* host, uint16_t port);
+  int connect(IPAddress ip, uint16_t port, int32_t timeout);
+  int connect(const char* host, uint16_t port, int32_t timeout);
+  int connect(IPAddress ip, uint16_t port, int32_t timeout, const char* hostname);  // Connect by IP, verify hostname
+  size_t write(uint8_t b);
+  size_t write(const uint8_t* buf, size_t size);
+  int available();
+  int read();
+  int read(uint8_t* buf, size_t size);
+  int peek();
+  void flush();
+  void stop();
+  uint8_t connected();
+  operator bool() { return connected(); }
+
+  bool sessionResumed() { return _resumed; }          // Last handshake skipped the certificate exchange
+  unsigned long handshakeTime() { return _handshakeTime; }  // Duration of last TLS handshake (ms)
+
+private:
+  bool setupConfig();
+  int startTls(const char* host);
+
+  WiFiClient _tcp;
+  mbedtls_net_context _net;
+  mbedtls_ssl_context _ssl;
+  mbedtls_ssl_config _conf;
+  mbedtls_x509_crt _ca;
+  mbedtls_entropy_context _entropy;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_ssl_session _session;   // Session saved from the last handshake
+
+  const char* _caCert = nullptr;
+  unsigned long _handshakeTimeout = 10000;
+  unsigned long _handshakeTime = 0;
+  bool _seeded = false;
+  bool _configured = false;
+  bool _connected = false;
+  bool _haveSession = false;
+  bool _resumed = false;
+  int _peeked = -1;
+};
+
+#endif
\ No newline at end of file